@@ -0,0 +1,26 @@
+// Timing and JSON reporting shared by the micro-benchmarks.
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+#include <time.h>
+
+#define BENCH_ITERATIONS 2000000L // default iterations of every benchmark
+
+/// @brief monotonic clock in nanoseconds
+long bench_now()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000L + now.tv_nsec;
+}
+
+/// @brief prints benchmark result as a JSON object on one line
+void bench_report(const char *name, long iterations, long elapsed)
+{
+    printf("{\"name\": \"%s\", \"iterations\": %ld, \"total_ns\": %ld, \"ns_per_op\": %.2f}\n", name, iterations, elapsed, (double)elapsed / iterations);
+    fflush(stdout);
+}
+
+#endif
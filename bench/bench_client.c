@@ -0,0 +1,52 @@
+// Micro-benchmarks of the client message parser.
+// client.c is included whole, its main() renamed, so the benchmarked code is the shipped one.
+// Prints one JSON object per benchmark on stdout.
+
+#define main client_main
+#include "../client.c"
+#undef main
+
+#include "bench.h"
+
+volatile long sink; // keeps results alive
+
+/// @brief benchmarks get_ok_message() on the given message
+void bench_get_ok_message(const char *name, const char *string, long iterations)
+{
+    long start = bench_now();
+    for (long i = 0; i < iterations; i++)
+    {
+        int attempts = 0;
+        char *msg = NULL;
+        sink += get_ok_message(string, &attempts, &msg) + attempts;
+        free(msg);
+    }
+    bench_report(name, iterations, bench_now() - start);
+}
+
+/// @brief benchmarks retrieve_message() on the given message
+void bench_retrieve_message(const char *name, const char *string, long iterations)
+{
+    long start = bench_now();
+    for (long i = 0; i < iterations; i++)
+    {
+        commands cmd = ERR;
+        int attempts = 0;
+        char *msg = NULL;
+        sink += retrieve_message(string, &cmd, &attempts, &msg) + cmd;
+        free(msg);
+    }
+    bench_report(name, iterations, bench_now() - start);
+}
+
+int main(int argc, char *argv[])
+{
+    long iterations = argc > 1 ? atol(argv[1]) : BENCH_ITERATIONS;
+
+    bench_get_ok_message("client.get_ok_message", "OK 3 -+*--\n", iterations);
+    bench_get_ok_message("client.get_ok_message.welcome", "OK 6 5 it Welcome on the server!\n", iterations);
+    bench_retrieve_message("client.retrieve_message.ok", "OK 3 -+*--\n", iterations);
+    bench_retrieve_message("client.retrieve_message.end", "END 6 caldo\n", iterations);
+
+    return 0;
+}
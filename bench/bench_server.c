@@ -0,0 +1,71 @@
+// Micro-benchmarks of the server message parser and guess scorer.
+// server.c is included whole, its main() renamed, so the benchmarked code is the shipped one.
+// Prints one JSON object per benchmark on stdout.
+
+#define main server_main
+#include "../server.c"
+#undef main
+
+#include "bench.h"
+
+volatile long sink; // keeps results alive
+
+/// @brief benchmarks parser on the given message
+void bench_retrieve_message(const char *name, parser_t retrieve_message, const char *string, long iterations)
+{
+    long start = bench_now();
+    for (long i = 0; i < iterations; i++)
+    {
+        commands cmd;
+        char *msg = NULL;
+        sink += retrieve_message(string, &cmd, &msg);
+        free(msg);
+    }
+    bench_report(name, iterations, bench_now() - start);
+}
+
+/// @brief benchmarks scorer on the given words
+void bench_check_word(const char *name, scorer_t check_word, const char *serverWord, const char *userWord, long iterations)
+{
+    char guess[MAX_WORD_LENGTH + 1];
+    strcpy(guess, userWord);
+
+    long start = bench_now();
+    for (long i = 0; i < iterations; i++)
+    {
+        char *result = check_word(serverWord, guess);
+        sink += result[0];
+        free(result);
+    }
+    bench_report(name, iterations, bench_now() - start);
+}
+
+/// @brief benchmarks feedback cache lookups, all hits after the first one
+void bench_cached_check_word(const char *name, const game_variant *variant, const char *serverWord, const char *userWord, long iterations)
+{
+    char guess[MAX_WORD_LENGTH + 1];
+    strcpy(guess, userWord);
+
+    long start = bench_now();
+    for (long i = 0; i < iterations; i++)
+        sink += cached_check_word(variant, serverWord, guess)[0];
+    bench_report(name, iterations, bench_now() - start);
+}
+
+int main(int argc, char *argv[])
+{
+    long iterations = argc > 1 ? atol(argv[1]) : BENCH_ITERATIONS;
+    game_variant italian;
+    init_variant(&italian, DEFAULT_LANGUAGE, DEFAULT_LENGTH, NULL);
+
+    bench_retrieve_message("server.retrieve_message_5", retrieve_message_5, "WORD caldo\n", iterations);
+    bench_retrieve_message("server.retrieve_message_8", retrieve_message_8, "WORD notebook\n", iterations);
+    bench_retrieve_message("server.retrieve_message_5.not_alpha", retrieve_message_5, "WORD cal1o\n", iterations);
+    bench_retrieve_message("server.retrieve_message_5.quit", retrieve_message_5, "QUIT\n", iterations);
+    bench_check_word("server.check_word_5", check_word_5, "caldo", "lacdo", iterations);
+    bench_check_word("server.check_word_8", check_word_8, "notebook", "booknote", iterations);
+    bench_cached_check_word("server.cached_check_word_5", &italian, "caldo", "lacdo", iterations);
+
+    free_variant(&italian);
+    return 0;
+}
@@ -0,0 +1,55 @@
+#!/bin/sh
+# End-to-end loopback benchmark: starts the server and pushes games through one
+# client in batch mode. Prints one JSON object on stdout.
+#
+# Usage: bench/loopback.sh [<binary-dir>] [<games>]
+
+BIN=${1:-.}
+GAMES=${2:-2000}
+PORT=$((20000 + $$ % 20000)) # avoid ports left in TIME_WAIT by previous runs
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+# every game tries the built-in words in order, so games end after 1 to 6 attempts
+awk -v games="$GAMES" 'BEGIN {
+    for (i = 0; i < games; i++)
+        printf "fessa\ncaldo\nmucca\nleale\npasto\nadori\n\n"
+}' > "$WORK/guesses.txt"
+
+"$BIN/server" --seed=1 "$PORT" 6 2>/dev/null &
+SERVER=$!
+
+# the control socket is created once the server listens, instrumented builds may take a while
+TRIES=0
+while [ ! -S "/tmp/server-$PORT.sock" ]; do
+    if ! kill -0 "$SERVER" 2>/dev/null || [ "$TRIES" -ge 300 ]; then
+        echo "loopback: server on port $PORT not listening" >&2
+        kill -TERM "$SERVER" 2>/dev/null
+        exit 1
+    fi
+    TRIES=$((TRIES + 1))
+    sleep 0.1
+done
+
+START=$(date +%s%N)
+"$BIN/client" --batch="$WORK/guesses.txt" 127.0.0.1 "$PORT" > "$WORK/results.tsv" 2>/dev/null
+END=$(date +%s%N)
+
+kill -TERM "$SERVER"
+wait "$SERVER"
+
+# rates are only meaningful if every game was played
+PLAYED=$(awk -F '\t' 'NR > 1 && $1 != last { played++; last = $1 } END { print played + 0 }' "$WORK/results.tsv")
+if [ "$PLAYED" -lt "$GAMES" ]; then
+    echo "loopback: only $PLAYED of $GAMES games played" >&2
+    exit 1
+fi
+
+awk -F '\t' -v elapsed=$((END - START)) -v games="$PLAYED" '
+    $5 == "OK" || $5 == "PERFECT" { messages++ }
+    $5 == "PERFECT" { won++ }
+    END {
+        seconds = elapsed / 1e9
+        printf "{\"name\": \"loopback.batch_games\", \"games\": %d, \"won\": %d, \"messages\": %d, \"total_ns\": %d, \"games_per_second\": %.1f, \"messages_per_second\": %.1f}\n",
+            games, won, messages, elapsed, games / seconds, messages / seconds
+    }' "$WORK/results.tsv"
@@ -0,0 +1,23 @@
+#!/bin/sh
+# Runs every benchmark and prints a single JSON document on stdout.
+#
+# Usage: bench/run.sh [<binary-dir>] [<iterations>] [<games>]
+
+BIN=${1:-.}
+ITERATIONS=${2:-2000000}
+GAMES=${3:-2000}
+DIR=$(dirname "$0")
+
+# end-to-end benchmark first, no document if it fails
+LOOPBACK=$("$DIR/loopback.sh" "$BIN" "$GAMES") || exit 1
+
+printf '{\n  "commit": "%s",\n  "date": "%s",\n  "compiler": "%s",\n  "results": [\n' \
+    "$(git rev-parse --short HEAD 2>/dev/null)" "$(date -u +%Y-%m-%dT%H:%M:%SZ)" "$(${CC:-cc} --version | head -n 1)"
+
+{
+    "$BIN/bench_server" "$ITERATIONS" 2>/dev/null
+    "$BIN/bench_client" "$ITERATIONS" 2>/dev/null
+    echo "$LOOPBACK"
+} | sed -e 's/^/    /' -e '$!s/$/,/'
+
+printf '  ]\n}\n'
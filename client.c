@@ -10,6 +10,8 @@
 
 #define MAX 256
 #define TOLLERANCE 6
+#define DEFAULT_LENGTH 5 // word length if the server doesn't send it
+#define MAX_LANGUAGE 8
 
 #define COLOR_RED "\x1b[31m"
 #define COLOR_GREEN "\x1b[32m"
@@ -22,6 +24,9 @@
 #define CLOSE_EXECUTION 0
 #define CONTINUE_EXECUTION 1
 
+#define BATCH_OPTION "--batch" // --batch[=<file>], guesses from stdin or file
+#define MAX_GUESSES 64         // guesses read for a single game
+
 typedef enum enum_commands
 {
     OK,      // received message
@@ -33,6 +38,12 @@ typedef enum enum_commands
 
 typedef struct sockaddr_in *sockaddr_t;
 
+typedef struct line_reader
+{
+    char data[MAX * 4]; // bytes read from server but not returned yet
+    size_t length;      // bytes in data
+} line_reader;
+
 /// @brief prints red string
 void print_error(const char *string)
 {
@@ -139,7 +150,7 @@ int get_message(const char *string, char **msg)
         err &= 0;
 
     // get message
-    *msg = malloc(strlen(string + needle + 1) + 1);
+    *msg = malloc(strlen(string + needle) + 1);
     strcpy(*msg, string + needle);
     if (string[strlen(string) - 1] != '\n')
         err &= 0;
@@ -222,8 +233,9 @@ int retrieve_message(const char *string, commands *cmd, int *attempts, char **ms
 }
 
 /// @brief checks if the word is admitted
+/// @param length word length of the game
 /// @return 1 if the word is admitted, 0 otherwise
-int check_word(char *word)
+int check_word(char *word, int length)
 {
     if (strlen(word) == 0 || word == NULL) // no word
     {
@@ -238,9 +250,10 @@ int check_word(char *word)
             return 0;
         }
 
-    if (strlen(word) != 5) // word length wrong
+    if (strlen(word) != (size_t)length) // word length wrong
     {
-        print_warning("The word isn't 5 letters!");
+        fprintf(stderr, COLOR_YELLOW "The word isn't %d letters!\n" COLOR_RESET, length);
+        fflush(stderr);
         return 0;
     }
 
@@ -272,6 +285,8 @@ void socket_chat(int mySocket)
     char buffer[MAX] = "";
     commands cmd;                          // command received
     int attempts = 0, max_attempts = 0;    // number of attempts
+    int wordLength = DEFAULT_LENGTH;       // letters of the word to guess
+    char language[MAX_LANGUAGE] = "";      // language of the word to guess
     char *message = NULL;                  // received message
     int actual_state = CONTINUE_EXECUTION; // execution state
 
@@ -285,7 +300,19 @@ void socket_chat(int mySocket)
         {
             max_attempts = attempts; // set max attempts to server set attempts
             attempts = 0;
-            print_warning(message); // print welcome message
+
+            int welcomeStart = 0;
+            if (sscanf(message, "%d %7s %n", &wordLength, language, &welcomeStart) == 2 && welcomeStart > 0) // game variant sent by server
+            {
+                print_warning(message + welcomeStart); // print welcome message
+                fprintf(stderr, "Playing with %d letters words (%s).\n", wordLength, language);
+                fflush(stderr);
+            }
+            else
+            {
+                wordLength = DEFAULT_LENGTH;
+                print_warning(message); // print welcome message
+            }
         }
         else
             print_error(message); // print error message
@@ -309,10 +336,10 @@ void socket_chat(int mySocket)
 
             do // ask word to user until correctly formatted
             {
-                fprintf(stderr, "\nGuess the 5 letter word: ");
+                fprintf(stderr, "\nGuess the %d letter word: ", wordLength);
                 fflush(stderr);
                 fscanf(stdin, " %s", parola); // get word from user
-            } while ((!check_word(parola) && strlen(parola) == 5) || strlen(parola) != 5);
+            } while (!check_word(parola, wordLength));
 
             sprintf(clientString, "WORD %s\n", parola);              // prepare command to send to server
             write(mySocket, clientString, strlen(clientString));     // send command to server
@@ -381,12 +408,228 @@ void socket_chat(int mySocket)
     };
 }
 
+/// @brief reads next line sent by server, skipping zero padding of the messages
+/// @return 1 if a line was read, 0 if the server closed the connection
+int read_line(int mySocket, line_reader *reader, char *line)
+{
+    while (1)
+    {
+        size_t padding = 0;
+        while (padding < reader->length && reader->data[padding] == '\0')
+            padding++;
+        memmove(reader->data, reader->data + padding, reader->length - padding);
+        reader->length -= padding;
+
+        char *newline = memchr(reader->data, '\n', reader->length);
+        if (newline != NULL) // complete line
+        {
+            size_t lineLength = newline - reader->data + 1;
+            size_t copied = lineLength < MAX - 1 ? lineLength : MAX - 1;
+            memcpy(line, reader->data, copied);
+            line[copied] = '\0';
+            memmove(reader->data, reader->data + lineLength, reader->length - lineLength);
+            reader->length -= lineLength;
+            return 1;
+        }
+
+        if (reader->length == sizeof(reader->data)) // line too long
+            return 0;
+
+        ssize_t responseStatus = read(mySocket, reader->data + reader->length, sizeof(reader->data) - reader->length);
+        if (responseStatus <= 0)
+            return 0;
+        reader->length += responseStatus;
+    }
+}
+
+/// @brief reads guesses of the next game, one per line until an empty line
+/// @return number of guesses read, -1 at end of input
+int read_guesses(FILE *input, char guesses[][MAX])
+{
+    char line[MAX];
+    int count = 0;
+
+    while (fgets(line, sizeof(line), input) != NULL)
+    {
+        line[strcspn(line, "\r\n")] = '\0'; // strip newline
+
+        if (line[0] == '\0') // empty line ends the game
+        {
+            if (count > 0)
+                break;
+        }
+        else if (count < MAX_GUESSES)
+            strcpy(guesses[count++], line);
+        else
+            print_warning("Too many guesses for a single game, ignored..");
+    }
+
+    return count > 0 ? count : -1;
+}
+
+/// @brief prints machine-readable result line
+void print_result(int game, int attempt, const char *guess, const char *pattern, const char *outcome, const char *word)
+{
+    printf("%d\t%d\t%s\t%s\t%s\t%s\n", game, attempt, guess, pattern, outcome, word);
+}
+
+/// @brief plays a game sending every guess at once, without waiting for replies, when the server allows it
+/// @return 1 if the word was guessed, 0 otherwise
+int batch_game(sockaddr_t myServer, char guesses[][MAX], int count, int game)
+{
+    int mySocket = create_socket();
+    connect_socket_to_server(mySocket, (struct sockaddr *)myServer);
+
+    line_reader reader = {0};
+    char line[MAX] = "";
+    commands cmd;
+    char *message = NULL;
+    char language[8] = "";
+    int attempts = 0, max_attempts = 0, wordLength = DEFAULT_LENGTH;
+
+    if (!read_line(mySocket, &reader, line) || !retrieve_message(line, &cmd, &max_attempts, &message) || cmd != OK) // welcome message
+    {
+        print_error("Welcome message not received...");
+        close(mySocket);
+        return 0;
+    }
+    int pipeline = sscanf(message, "%d %7s", &wordLength, language) == 2; // servers sending the game variant handle pipelined messages
+    free(message);
+
+    // prepare every admitted guess, up to the attempts allowed
+    char request[MAX_GUESSES * (MAX + 6)] = "";
+    size_t requestLength = 0;
+    size_t messageStart[MAX_GUESSES + 2]; // offset of every message in request, then request end
+    int messageCount = 0;
+    int sent[MAX_GUESSES]; // guesses sent, in order
+    int sentCount = 0;
+
+    for (int i = 0; i < count; i++)
+        if (!check_word(guesses[i], wordLength))
+            print_result(game, 0, guesses[i], "-", "INVALID", "-");
+        else if (sentCount == max_attempts)
+            print_result(game, 0, guesses[i], "-", "SKIPPED", "-");
+        else
+        {
+            messageStart[messageCount++] = requestLength;
+            requestLength += sprintf(request + requestLength, "WORD %s\n", guesses[i]);
+            sent[sentCount++] = i;
+        }
+
+    if (sentCount < max_attempts) // leave if the guesses are over before the attempts
+    {
+        messageStart[messageCount++] = requestLength;
+        requestLength += sprintf(request + requestLength, "QUIT\n");
+    }
+    messageStart[messageCount] = requestLength;
+
+    if (pipeline)
+        write(mySocket, request, requestLength); // send everything at once
+    else if (messageCount > 0)
+        write(mySocket, request, messageStart[1]); // one message at a time, the next one after every reply
+
+    // replies come in the same order as guesses
+    int answered = 0, perfect = 0, finished = 0, over = 0;
+    while (!over && read_line(mySocket, &reader, line))
+    {
+        message = NULL;
+        cmd = -1; // unknown message
+        retrieve_message(line, &cmd, &attempts, &message);
+        if (message != NULL)
+            message[strcspn(message, "\n")] = '\0';
+        const char *guess = answered < sentCount ? guesses[sent[answered]] : "-";
+
+        switch (cmd)
+        {
+        case OK:
+            print_result(game, attempts, guess, message, "OK", "-");
+            answered++;
+            if (!pipeline && answered < messageCount) // send next message
+                write(mySocket, request + messageStart[answered], messageStart[answered + 1] - messageStart[answered]);
+            break;
+        case PERFECT:
+            memset(line, '*', wordLength);
+            line[wordLength] = '\0';
+            print_result(game, answered + 1, guess, line, "PERFECT", guess);
+            answered++;
+            perfect = finished = 1;
+            break;
+        case END:
+            if (finished) // a win on the last attempt ends the game already
+                break;
+            print_result(game, attempts, "-", "-", "END", message);
+            finished = 1;
+            break;
+        case QUIT:
+            if (!finished) // game left before the end
+            {
+                char word[MAX] = "-";
+                sscanf(message, "%*[^']'%[^']", word);
+                print_result(game, answered, "-", "-", "QUIT", word);
+            }
+            over = 1;
+            break;
+        case ERR:
+            print_result(game, answered + 1, guess, "-", "ERR", "-");
+            print_error(message);
+            answered++;
+            over = 1;
+            break;
+        default:
+            break;
+        }
+        free(message);
+    }
+
+    for (int i = answered; i < sentCount; i++) // guesses after the end of the game
+        print_result(game, 0, guesses[sent[i]], "-", "SKIPPED", "-");
+
+    fflush(stdout);
+    close(mySocket);
+    return perfect;
+}
+
+/// @brief plays a game for every group of guesses in input
+void batch_chat(sockaddr_t myServer, FILE *input)
+{
+    char guesses[MAX_GUESSES][MAX];
+    int games = 0, won = 0, count;
+
+    printf("game\tattempt\tguess\tpattern\toutcome\tword\n");
+    while ((count = read_guesses(input, guesses)) > 0)
+        won += batch_game(myServer, guesses, count, ++games);
+
+    fprintf(stderr, COLOR_GREEN "Played %d games, %d won.\n" COLOR_RESET, games, won);
+    fflush(stderr);
+}
+
 int main(int argc, char *argv[])
 {
+    FILE *batchInput = NULL; // guesses of batch mode, NULL if interactive
+
+    if (argc > 1 && strncmp(argv[1], "--", 2) == 0) // drop option from arguments
+    {
+        if (strcmp(argv[1], BATCH_OPTION) == 0)
+            batchInput = stdin;
+        else if (strncmp(argv[1], BATCH_OPTION "=", strlen(BATCH_OPTION "=")) != 0)
+        {
+            fprintf(stderr, COLOR_RED "Unknown option %s. Usage: %s [" BATCH_OPTION "[=<file>]] <server> <port>\n" COLOR_RESET, argv[1], argv[0]);
+            exit(EXIT_FAILURE);
+        }
+        else if ((batchInput = fopen(argv[1] + strlen(BATCH_OPTION "="), "r")) == NULL)
+        {
+            fprintf(stderr, COLOR_RED "Cannot open %s.\n" COLOR_RESET, argv[1] + strlen(BATCH_OPTION "="));
+            exit(EXIT_FAILURE);
+        }
+        argv[1] = argv[0];
+        argv++;
+        argc--;
+    }
+
     // check arguments
     if (argc < 3)
     {
-        fprintf(stderr, COLOR_RED "Incorrect arguments. Usage: %s <server> <port>\n" COLOR_RESET, argv[0]);
+        fprintf(stderr, COLOR_RED "Incorrect arguments. Usage: %s [" BATCH_OPTION "[=<file>]] <server> <port>\n" COLOR_RESET, argv[0]);
         exit(EXIT_FAILURE);
     }
 
@@ -397,12 +640,21 @@ int main(int argc, char *argv[])
         exit(EXIT_FAILURE);
     }
 
-    // create and verify streaming socket
-    int mySocket = create_socket();
-
     // server setup and assign
     sockaddr_t myServer = init_server(AF_INET, inet_addr(argv[1]), htons(atoi(argv[2])));
 
+    if (batchInput != NULL) // one connection for every game
+    {
+        batch_chat(myServer, batchInput);
+        if (batchInput != stdin)
+            fclose(batchInput);
+        free(myServer);
+        return 0;
+    }
+
+    // create and verify streaming socket
+    int mySocket = create_socket();
+
     // connect the client socket to server socket
     connect_socket_to_server(mySocket, (struct sockaddr *)myServer);
 
@@ -0,0 +1,29 @@
+// On-disk format of the game results journal, shared by server.c and journal_stats.c.
+// The journal is a plain sequence of fixed-size records, appended with O_APPEND.
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdint.h>
+
+#define JOURNAL_LANGUAGE 8 // language code bytes, NUL padded
+#define JOURNAL_WORD 8     // secret word bytes, NUL padded
+
+#define JOURNAL_PERFECT 1 // word guessed
+#define JOURNAL_END 2     // no more attempts
+
+typedef struct journal_record
+{
+    int64_t timestamp;               // end of the game, seconds since epoch
+    uint32_t peer;                   // client IPv4 address, network byte order
+    uint8_t outcome;                 // JOURNAL_PERFECT or JOURNAL_END
+    uint8_t attempts;                // attempts used
+    uint8_t length;                  // letters of the secret word
+    uint8_t reserved;                // always 0
+    char language[JOURNAL_LANGUAGE]; // language of the game variant
+    char secret[JOURNAL_WORD];       // word to guess
+} journal_record;
+
+_Static_assert(sizeof(journal_record) == 32, "journal records must be 32 bytes");
+
+#endif
@@ -0,0 +1,170 @@
+#include <arpa/inet.h> // inet_ntoa()
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "journal.h"
+
+#define COLOR_RED "\x1b[31m"
+#define COLOR_RESET "\x1b[0m"
+
+typedef struct aggregate
+{
+    int games;            // games played
+    int perfect;          // games won
+    long attempts;        // attempts of won games
+    int distribution[11]; // won games by attempts used
+} aggregate;
+
+/// @brief prints red string
+void print_error(const char *string)
+{
+    fprintf(stderr, COLOR_RED "%s\n" COLOR_RESET, string);
+    fflush(stderr);
+}
+
+/// @brief appends every record of the journal file to the given array
+/// @return 1 if the file was read, 0 otherwise
+int load_journal(const char *path, journal_record **records, size_t *count, size_t *capacity)
+{
+    FILE *journalFile = fopen(path, "rb");
+    if (journalFile == NULL)
+    {
+        fprintf(stderr, COLOR_RED "Cannot open journal %s.\n" COLOR_RESET, path);
+        return 0;
+    }
+
+    journal_record record;
+    while (fread(&record, sizeof(record), 1, journalFile) == 1)
+    {
+        if (*count == *capacity) // grow array
+        {
+            *capacity = *capacity ? *capacity * 2 : 1024;
+            *records = realloc(*records, *capacity * sizeof(journal_record));
+        }
+        (*records)[(*count)++] = record;
+    }
+
+    if (!feof(journalFile))
+        fprintf(stderr, COLOR_RED "Error reading journal %s.\n" COLOR_RESET, path);
+    fclose(journalFile);
+    return 1;
+}
+
+/// @brief orders records by language and secret word
+int compare_word(const void *a, const void *b)
+{
+    const journal_record *first = a, *second = b;
+    int result = strncmp(first->language, second->language, JOURNAL_LANGUAGE);
+    if (result == 0)
+        result = strncmp(first->secret, second->secret, JOURNAL_WORD);
+    return result;
+}
+
+/// @brief orders records by client address
+int compare_peer(const void *a, const void *b)
+{
+    uint32_t first = ntohl(((const journal_record *)a)->peer), second = ntohl(((const journal_record *)b)->peer);
+    return (first > second) - (first < second);
+}
+
+/// @brief adds record to aggregate
+void add_record(aggregate *total, const journal_record *record)
+{
+    total->games++;
+    if (record->outcome == JOURNAL_PERFECT)
+    {
+        total->perfect++;
+        total->attempts += record->attempts;
+        if (record->attempts < sizeof(total->distribution) / sizeof(total->distribution[0]))
+            total->distribution[record->attempts]++;
+    }
+}
+
+/// @brief prints games, win rate and average attempts of the aggregate
+void print_aggregate(const char *name, const aggregate *total)
+{
+    printf("%-20s %6d %6d %6.1f%% %8.2f ", name, total->games, total->perfect, 100.0 * total->perfect / total->games, total->perfect ? (double)total->attempts / total->perfect : 0.0);
+    for (int i = 1; i < (int)(sizeof(total->distribution) / sizeof(total->distribution[0])); i++)
+        printf(" %4d", total->distribution[i]);
+    printf("\n");
+}
+
+/// @brief prints table header
+void print_header(const char *name)
+{
+    printf("%-20s %6s %6s %7s %8s ", name, "games", "won", "win", "attempts");
+    for (int i = 1; i <= 10; i++)
+        printf(" %4d", i);
+    printf("\n");
+}
+
+/// @brief prints one aggregate for every run of records equal according to compare
+/// @param word 1 to name runs by word, 0 by client address
+void print_runs(journal_record *records, size_t count, int (*compare)(const void *, const void *), int word)
+{
+    qsort(records, count, sizeof(journal_record), compare);
+
+    for (size_t start = 0; start < count;)
+    {
+        aggregate total = {0};
+        size_t end = start;
+        for (; end < count && compare(&records[start], &records[end]) == 0; end++)
+            add_record(&total, &records[end]);
+
+        char name[32] = "";
+        if (word)
+        {
+            int length = records[start].length < JOURNAL_WORD ? records[start].length : JOURNAL_WORD; // corrupt records may exceed secret
+            snprintf(name, sizeof(name), "%.*s/%.*s", JOURNAL_LANGUAGE, records[start].language, length, records[start].secret);
+        }
+        else
+        {
+            struct in_addr address = {records[start].peer};
+            snprintf(name, sizeof(name), "%s", inet_ntoa(address));
+        }
+        print_aggregate(name, &total);
+
+        start = end;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    // check arguments
+    if (argc < 2)
+    {
+        fprintf(stderr, COLOR_RED "Incorrect arguments. Usage: %s <journal-file>...\n" COLOR_RESET, argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    journal_record *records = NULL;
+    size_t count = 0, capacity = 0;
+    for (int i = 1; i < argc; i++) // read every journal file, rolled over ones included
+        if (!load_journal(argv[i], &records, &count, &capacity))
+            exit(EXIT_FAILURE);
+
+    if (count == 0)
+    {
+        print_error("No game in the journal.");
+        free(records);
+        return 0;
+    }
+
+    aggregate total = {0};
+    for (size_t i = 0; i < count; i++)
+        add_record(&total, &records[i]);
+    print_header("");
+    print_aggregate("all games", &total);
+
+    printf("\n");
+    print_header("word");
+    print_runs(records, count, compare_word, 1);
+
+    printf("\n");
+    print_header("player");
+    print_runs(records, count, compare_peer, 0);
+
+    free(records);
+    return 0;
+}
@@ -0,0 +1,316 @@
+#include <arpa/inet.h> // inet_addr()
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h> // bzero()
+#include <sys/socket.h>
+#include <sys/time.h> // timeval
+#include <time.h>
+#include <unistd.h> // read(), write(), close()
+
+#include "trace.h"
+
+#define FAST_OPTION "--fast"
+#define RECEIVE_TIMEOUT 5 // seconds waited for a server response
+
+#define COLOR_RED "\x1b[31m"
+#define COLOR_GREEN "\x1b[32m"
+#define COLOR_YELLOW "\x1b[33m"
+#define COLOR_RESET "\x1b[0m"
+
+typedef struct trace_message
+{
+    trace_record record; // traced record
+    char *data;          // message, trailing zeros restored
+} trace_message;
+
+typedef struct replay_stats
+{
+    int sessions;        // sessions replayed
+    int messages;        // client messages sent, newline terminated
+    int mismatches;      // responses different from the traced ones
+    long *latencies;     // microseconds between message and complete response
+    int latencyCount;    // latencies measured
+    int latencyCapacity; // latencies allocated
+} replay_stats;
+
+/// @brief prints red string
+void print_error(const char *string)
+{
+    fprintf(stderr, COLOR_RED "%s\n" COLOR_RESET, string);
+    fflush(stderr);
+}
+
+/// @brief prints yellow string
+void print_warning(const char *string)
+{
+    fprintf(stderr, COLOR_YELLOW "%s\n" COLOR_RESET, string);
+    fflush(stderr);
+}
+
+/// @brief monotonic clock in microseconds
+long now_us()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000L + now.tv_nsec / 1000;
+}
+
+/// @brief reads the whole trace file
+/// @return number of messages read, -1 on error
+int load_trace(const char *path, trace_header *header, trace_message **messages)
+{
+    FILE *traceFile = fopen(path, "rb");
+    if (traceFile == NULL || fread(header, sizeof(*header), 1, traceFile) != 1 || memcmp(header->magic, TRACE_MAGIC, sizeof(header->magic)) != 0)
+    {
+        fprintf(stderr, COLOR_RED "Cannot read trace %s.\n" COLOR_RESET, path);
+        if (traceFile != NULL)
+            fclose(traceFile);
+        return -1;
+    }
+
+    int count = 0, capacity = 0;
+    trace_record record;
+    while (fread(&record, sizeof(record), 1, traceFile) == 1)
+    {
+        if (count == capacity) // grow array
+        {
+            capacity = capacity ? capacity * 2 : 1024;
+            *messages = realloc(*messages, capacity * sizeof(trace_message));
+        }
+
+        trace_message *message = &(*messages)[count++];
+        message->record = record;
+        message->data = calloc(1, record.length + 1); // trailing zeros restored by calloc
+        if (record.zeros > record.length || fread(message->data, 1, record.length - record.zeros, traceFile) != (size_t)(record.length - record.zeros))
+        {
+            print_warning("Trace truncated, replaying complete records only..");
+            count--;
+            free(message->data);
+            break;
+        }
+    }
+
+    fclose(traceFile);
+    return count;
+}
+
+/// @brief connect to the server
+/// @return connected socket
+int connect_to_server(const struct sockaddr_in *serverAddress)
+{
+    int mySocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    struct timeval timeout = {RECEIVE_TIMEOUT, 0};
+
+    if (mySocket < 0 || connect(mySocket, (const struct sockaddr *)serverAddress, sizeof(*serverAddress)) < 0)
+    {
+        print_error("Connection with the server failed...");
+        exit(EXIT_FAILURE);
+    }
+    setsockopt(mySocket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    return mySocket;
+}
+
+/// @brief counts the newline terminated messages of a traced read, several when pipelined
+int count_messages(const char *data, size_t length)
+{
+    int count = 0;
+    for (const char *newline = data; (newline = memchr(newline, '\n', length - (newline - data))) != NULL; newline++)
+        count++;
+    return count;
+}
+
+/// @brief reads the responses expected by the trace and compares them
+/// @param sentAt time the last message was sent, -1 if none
+void receive_expected(int mySocket, const char *expected, size_t expectedLength, long sentAt, replay_stats *stats)
+{
+    if (expectedLength == 0)
+        return;
+
+    char *received = calloc(1, expectedLength);
+    size_t receivedLength = 0;
+    while (receivedLength < expectedLength) // responses may come in pieces
+    {
+        ssize_t responseStatus = read(mySocket, received + receivedLength, expectedLength - receivedLength);
+        if (responseStatus <= 0) // server closed or timed out
+            break;
+        receivedLength += responseStatus;
+        if (memcmp(received, expected, receivedLength) != 0) // already mismatching, don't wait for the rest
+            break;
+    }
+
+    if (sentAt >= 0) // response to a client message
+    {
+        if (stats->latencyCount == stats->latencyCapacity) // grow array
+        {
+            stats->latencyCapacity = stats->latencyCapacity ? stats->latencyCapacity * 2 : 1024;
+            stats->latencies = realloc(stats->latencies, stats->latencyCapacity * sizeof(long));
+        }
+        stats->latencies[stats->latencyCount++] = now_us() - sentAt;
+    }
+
+    if (receivedLength != expectedLength || memcmp(received, expected, expectedLength) != 0)
+        stats->mismatches++;
+    free(received);
+}
+
+/// @brief sleeps until the record is due according to traced timing
+/// @param fast 1 to return immediately
+void wait_until(const trace_record *record, const trace_record *first, long replayStart, int fast)
+{
+    if (fast)
+        return;
+
+    long wait = (record->timestamp - first->timestamp) - (now_us() - replayStart);
+    if (wait > 0)
+        usleep(wait);
+}
+
+/// @brief replays every message of the trace against the server
+/// @param fast 1 to send messages as fast as possible, 0 to keep traced timing
+void replay(const trace_message *messages, int count, const struct sockaddr_in *serverAddress, int fast, replay_stats *stats)
+{
+    int mySocket = -1;
+    char *expected = NULL; // server messages expected before the next client message
+    size_t expectedLength = 0, expectedCapacity = 0;
+    long sentAt = -1;
+    long replayStart = now_us();
+
+    for (int i = 0; i < count; i++)
+    {
+        const trace_record *record = &messages[i].record;
+
+        switch (record->type)
+        {
+        case TRACE_OPEN:
+            wait_until(record, &messages[0].record, replayStart, fast);
+            if (mySocket >= 0) // previous session not closed in the trace
+                close(mySocket);
+            mySocket = connect_to_server(serverAddress);
+            expectedLength = 0;
+            sentAt = -1;
+            stats->sessions++;
+            break;
+        case TRACE_OUT:
+            if (expectedLength + record->length > expectedCapacity) // grow buffer
+            {
+                expectedCapacity = (expectedLength + record->length) * 2;
+                expected = realloc(expected, expectedCapacity);
+            }
+            memcpy(expected + expectedLength, messages[i].data, record->length);
+            expectedLength += record->length;
+            break;
+        case TRACE_IN:
+        case TRACE_CLOSE:
+            if (mySocket < 0) // session opened before the trace
+                break;
+
+            receive_expected(mySocket, expected, expectedLength, sentAt, stats);
+            expectedLength = 0;
+
+            if (record->type == TRACE_IN)
+            {
+                wait_until(record, &messages[0].record, replayStart, fast);
+                sentAt = now_us();
+                if (send(mySocket, messages[i].data, record->length, MSG_NOSIGNAL) != (ssize_t)record->length) // session closed earlier than traced
+                {
+                    stats->mismatches++;
+                    close(mySocket); // skip rest of session
+                    mySocket = -1;
+                    break;
+                }
+                stats->messages += count_messages(messages[i].data, record->length);
+            }
+            else
+            {
+                close(mySocket);
+                mySocket = -1;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    if (mySocket >= 0)
+        close(mySocket);
+    free(expected);
+}
+
+/// @brief orders latencies
+int compare_latency(const void *a, const void *b)
+{
+    long first = *(const long *)a, second = *(const long *)b;
+    return (first > second) - (first < second);
+}
+
+/// @brief prints throughput and latency distribution
+void print_report(replay_stats *stats, long elapsed, unsigned long long seed)
+{
+    double seconds = elapsed / 1000000.0;
+
+    printf("Replayed %d sessions, %d messages in %.3f s\n", stats->sessions, stats->messages, seconds);
+    printf("Throughput: %.1f messages/s, %.1f sessions/s\n", stats->messages / seconds, stats->sessions / seconds);
+
+    if (stats->latencyCount > 0)
+    {
+        qsort(stats->latencies, stats->latencyCount, sizeof(long), compare_latency);
+        long *latency = stats->latencies;
+        int n = stats->latencyCount;
+        printf("Latency (us): min %ld, p50 %ld, p90 %ld, p99 %ld, max %ld\n", latency[0], latency[n / 2], latency[n * 90 / 100], latency[n * 99 / 100], latency[n - 1]);
+    }
+
+    printf("Mismatching responses: %d (server should be freshly started with --seed=%llu, the traced --variant list and max-attempts, and without --daily)\n", stats->mismatches, seed);
+}
+
+int main(int argc, char *argv[])
+{
+    int fast = 0;
+
+    if (argc > 1 && strcmp(argv[1], FAST_OPTION) == 0) // drop option from arguments
+    {
+        fast = 1;
+        argv[1] = argv[0];
+        argv++;
+        argc--;
+    }
+
+    // check arguments
+    if (argc < 4)
+    {
+        fprintf(stderr, COLOR_RED "Incorrect arguments. Usage: %s [" FAST_OPTION "] <trace-file> <server> <port>\n" COLOR_RESET, argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    // verify if server address is valid
+    if (inet_addr(argv[2]) == INADDR_NONE)
+    {
+        print_error("Server address is invalid!\n");
+        exit(EXIT_FAILURE);
+    }
+
+    trace_header header;
+    trace_message *messages = NULL;
+    int count = load_trace(argv[1], &header, &messages);
+    if (count < 0)
+        exit(EXIT_FAILURE);
+
+    struct sockaddr_in serverAddress;
+    bzero(&serverAddress, sizeof(serverAddress));
+    serverAddress.sin_family = AF_INET;
+    serverAddress.sin_addr.s_addr = inet_addr(argv[2]);
+    serverAddress.sin_port = htons(atoi(argv[3]));
+
+    replay_stats stats = {0};
+    long start = now_us();
+    replay(messages, count, &serverAddress, fast, &stats);
+    print_report(&stats, now_us() - start, (unsigned long long)header.seed);
+
+    for (int i = 0; i < count; i++)
+        free(messages[i].data);
+    free(messages);
+    free(stats.latencies);
+    return 0;
+}
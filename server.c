@@ -1,3 +1,5 @@
+#define _GNU_SOURCE // ppoll()
+
 #include <stdio.h>
 #include <netdb.h>
 #include <netinet/in.h>
@@ -7,24 +9,66 @@
 #include <strings.h>
 #include <time.h>
 #include <ctype.h> // isspace(), isalpha()
+#include <errno.h>
+#include <fcntl.h> // open()
+#include <poll.h>  // ppoll()
+#include <pthread.h>
+#include <signal.h> // sigaction(), sigprocmask()
 #include <sys/socket.h>
+#include <sys/stat.h> // fstat()
 #include <sys/types.h>
+#include <sys/un.h> // sockaddr_un
 #include <unistd.h> // read(), write(), close()
 
+#include "journal.h"
+#include "trace.h"
+
 #define MAX 256
 #define MAX_CONNECTIONS 5
-#define WORD_LENGTH 5
+#define MIN_WORD_LENGTH 4
+#define MAX_WORD_LENGTH 8
+#define MAX_VARIANTS 8 // game variants hosted at once
+#define MAX_LANGUAGE 8 // language code length
+#define DEFAULT_LANGUAGE "it"
+#define DEFAULT_LENGTH 5
 
 #define LISTENING 1
+#define DRAINING 0
 #define CONNECTION_OPENED 1
 #define CONNECTION_CLOSED 0
+#define CONNECTION_LOST 2 // client gone while answering, nothing more to send
+
+#define UPGRADE_OPTION "--upgrade"
+#define UPGRADE_SOCKET_PATH "/tmp/server-%d.sock" // control socket used to hand off the listening socket
+#define DRAIN_TIMEOUT 60                          // seconds left to running game after an upgrade
+
+#define DAILY_OPTION "--daily"
+#define DAILY_WINDOW (24 * 60 * 60) // seconds each daily word lasts
+
+#define VARIANT_OPTION "--variant" // --variant=<language>:<length>:<dictionary-file>
+
+#define JOURNAL_OPTION "--journal"           // --journal=<path>
+#define JOURNAL_QUEUE 1024                   // records waiting for the writer thread
+#define JOURNAL_SYNC_RECORDS 64              // fsync after this many records...
+#define JOURNAL_SYNC_MS 200                  // ...or this many milliseconds after the first unsynced one
+#define JOURNAL_MAX_SIZE (64L * 1024 * 1024) // roll over to a new file past this size
+
+#define TRACE_OPTION "--trace"   // --trace=<path>
+#define TRACE_BUFFER (64 * 1024) // trace bytes buffered before writing
+#define SEED_OPTION "--seed"     // --seed=<n>
+
+#define USAGE "[" UPGRADE_OPTION "] [" DAILY_OPTION "[=<seconds>]] [" VARIANT_OPTION "=<language>:<length>:<dictionary-file>]... [" JOURNAL_OPTION "=<path>] [" TRACE_OPTION "=<path>] [" SEED_OPTION "=<n>] <port> [<max-attempts>]"
+
+#define CACHE_SIZE 1024 // feedback cache slots, must be a power of two
+#define CACHE_PROBES 8  // slots checked before evicting an entry
 
 #define WELCOME_MESSAGE "Welcome on the server!\n"
 #define ERROR_MALFORMED_MESSAGE "ERR Malformed command!\n"
-#define ERROR_WRONG_LENGTH "ERR Word is not 5 letters!\n"
+#define ERROR_WRONG_LENGTH "ERR Word is not %d letters!\n"
 #define ERROR_CHAR_NOT_ALPHA "ERR Word is not alphabetic!\n"
 #define ERROR_DOUBLE_SPACE "ERR Double space present!\n"
 #define ERROR_WRONG_MESSAGE "ERR Wrong command!\n"
+#define ERROR_SERVER_SHUTDOWN "ERR Server shutting down, game aborted!\n"
 #define PERFECT_MESSAGE "OK PERFECT\n"
 
 #define COLOR_RED "\x1b[31m"
@@ -34,6 +78,9 @@
 
 const char *words[] = {"fessa", "caldo", "mucca", "leale", "pasto", "adori"};
 
+volatile sig_atomic_t stopRequested = 0; // set by SIGINT and SIGTERM
+sigset_t waitMask;                       // signal mask while waiting, SIGINT and SIGTERM blocked elsewhere
+
 typedef enum enum_commands
 {
     QUIT, // leave execution
@@ -42,6 +89,50 @@ typedef enum enum_commands
 
 typedef struct sockaddr_in *sockaddr_t;
 
+typedef struct feedback_entry
+{
+    char secret[MAX_WORD_LENGTH];      // word to guess
+    char guess[MAX_WORD_LENGTH];       // word sent by client
+    char pattern[MAX_WORD_LENGTH + 1]; // resulting feedback
+    char used;                         // slot holds an entry
+} feedback_entry;
+
+typedef struct feedback_cache
+{
+    feedback_entry slots[CACHE_SIZE]; // open addressing table
+    unsigned long hits;               // lookups answered by the cache
+    unsigned long misses;             // lookups answered by check_word()
+} feedback_cache;
+
+typedef int (*parser_t)(const char *string, commands *cmd, char **msg);
+typedef char *(*scorer_t)(const char *serverWord, char *userWord);
+
+typedef struct game_variant
+{
+    int length;                  // letters of every word
+    char language[MAX_LANGUAGE]; // dictionary language, sent in the greeting
+    const char **words;          // dictionary
+    int wordCount;               // words in the dictionary
+    parser_t retrieve_message;   // parser specialized for length
+    scorer_t check_word;         // scorer specialized for length
+    feedback_cache *cache;       // feedback of already scored guesses
+} game_variant;
+
+typedef struct journal
+{
+    int fd;                              // journal file, opened with O_APPEND
+    char path[MAX];                      // journal file path
+    off_t size;                          // bytes in the journal file
+    journal_record queue[JOURNAL_QUEUE]; // ring of records waiting for the writer thread
+    int head;                            // first queued record
+    int count;                           // queued records
+    int stop;                            // writer thread must flush and exit
+    pthread_mutex_t lock;                // protects queue and stop
+    pthread_cond_t notEmpty;             // signaled when records are queued
+    pthread_cond_t notFull;              // signaled when the writer empties the queue
+    pthread_t writer;                    // writer thread
+} journal;
+
 /// @brief prints red string
 void print_error(const char *string)
 {
@@ -63,9 +154,71 @@ void print_success(const char *string)
     fflush(stderr);
 }
 
+/// @brief create trace file and write its header, an existing file is never overwritten
+/// @param seed base seed, session n plays with seed + n
+/// @return resulting trace, NULL if it can't be created
+FILE *open_trace(const char *path, unsigned int seed)
+{
+    FILE *myTrace = fopen(path, "wbx"); // a draining server may still be writing an existing trace
+    if (myTrace == NULL)
+    {
+        fprintf(stderr, COLOR_RED "Cannot create trace %s: %s.\n" COLOR_RESET, path, strerror(errno));
+        return NULL;
+    }
+    setvbuf(myTrace, NULL, _IOFBF, TRACE_BUFFER);
+
+    trace_header header = {TRACE_MAGIC, seed};
+    fwrite(&header, sizeof(header), 1, myTrace);
+
+    fprintf(stderr, COLOR_GREEN "Tracing sessions to %s with seed %u..\n" COLOR_RESET, path, seed);
+    fflush(stderr);
+    return myTrace;
+}
+
+/// @brief appends message to the session trace, trailing zeros left out
+/// @param type TRACE_OPEN, TRACE_IN, TRACE_OUT or TRACE_CLOSE
+void trace_message(FILE *myTrace, unsigned int session, int type, const void *data, size_t length)
+{
+    if (myTrace == NULL) // tracing disabled
+        return;
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    trace_record record = {0};
+    record.timestamp = now.tv_sec * 1000000LL + now.tv_nsec / 1000;
+    record.session = session;
+    record.length = length;
+    record.type = type;
+    while (record.zeros < 255 && record.zeros < length && ((const char *)data)[length - 1 - record.zeros] == '\0')
+        record.zeros++;
+
+    fwrite(&record, sizeof(record), 1, myTrace);
+    if (length > record.zeros) // empty or all zero payloads have nothing left to write, data may be NULL
+        fwrite(data, 1, length - record.zeros, myTrace);
+}
+
+/// @brief writes message to client and appends it to the session trace
+ssize_t traced_write(FILE *myTrace, unsigned int session, int myConnectionSocket, const void *data, size_t length)
+{
+    ssize_t written = write(myConnectionSocket, data, length);
+    if (written > 0)
+        trace_message(myTrace, session, TRACE_OUT, data, written);
+    return written;
+}
+
+/// @brief closes connection and ends the session trace
+void close_connection(int myConnectionSocket, FILE *myTrace, unsigned int session)
+{
+    close(myConnectionSocket);
+    trace_message(myTrace, session, TRACE_CLOSE, NULL, 0);
+    if (myTrace != NULL)
+        fflush(myTrace); // session complete on disk
+}
+
 /// @brief if there's an incoming connection on the socket handle it
 /// @return connection socket
-int accept_connection(int mySocket, sockaddr_t myClientName, int attempts)
+int accept_connection(int mySocket, sockaddr_t myClientName, int attempts, const game_variant *variant, FILE *myTrace, unsigned int session)
 {
     int clientLength = sizeof(*myClientName);                                                               // client name length
     int myConnectionSocket = accept(mySocket, (struct sockaddr *)myClientName, (socklen_t *)&clientLength); // accept incoming connection on socket
@@ -82,8 +235,8 @@ int accept_connection(int mySocket, sockaddr_t myClientName, int attempts)
         fflush(stderr);
 
         char welcomeMessage[MAX] = "";
-        sprintf(welcomeMessage, "OK %d %s", attempts, WELCOME_MESSAGE);    // prepare welcome message
-        write(myConnectionSocket, welcomeMessage, strlen(welcomeMessage)); // send message to client
+        sprintf(welcomeMessage, "OK %d %d %s %s", attempts, variant->length, variant->language, WELCOME_MESSAGE); // prepare welcome message
+        traced_write(myTrace, session, myConnectionSocket, welcomeMessage, strlen(welcomeMessage));             // send message to client
     }
 
     return myConnectionSocket;
@@ -117,104 +270,468 @@ commands cmdcmp(const char *string, const char *cmd, commands val)
     return -1;
 }
 
-/// @brief retrieves command and message from the given string
-int retrieve_message(const char *string, commands *cmd, char **msg)
+// parser and scorer for every supported length
+#define WORD_LENGTH 4
+#include "word_variant.h"
+#define WORD_LENGTH 5
+#include "word_variant.h"
+#define WORD_LENGTH 6
+#include "word_variant.h"
+#define WORD_LENGTH 7
+#include "word_variant.h"
+#define WORD_LENGTH 8
+#include "word_variant.h"
+
+const parser_t parsers[] = {retrieve_message_4, retrieve_message_5, retrieve_message_6, retrieve_message_7, retrieve_message_8};
+const scorer_t scorers[] = {check_word_4, check_word_5, check_word_6, check_word_7, check_word_8};
+
+/// @brief hash secret and guess pair (FNV-1a)
+unsigned int hash_words(const char *serverWord, const char *userWord, int length)
 {
-    if (cmdcmp(string, "WORD", WORD) == WORD)
+    unsigned int hash = 2166136261u;
+
+    for (int i = 0; i < length; i++)
+        hash = (hash ^ (unsigned char)serverWord[i]) * 16777619u;
+    for (int i = 0; i < length; i++)
+        hash = (hash ^ (unsigned char)userWord[i]) * 16777619u;
+
+    return hash;
+}
+
+/// @brief looks up the feedback for the guess in the cache, running check_word() only on a miss
+/// @return processed word, owned by the cache
+const char *cached_check_word(const game_variant *variant, const char *serverWord, char *userWord)
+{
+    feedback_cache *cache = variant->cache;
+    int length = variant->length;
+    unsigned int home = hash_words(serverWord, userWord, length) & (CACHE_SIZE - 1);
+
+    for (unsigned int probe = 0; probe < CACHE_PROBES; probe++) // linear probing
     {
-        *cmd = WORD;
+        feedback_entry *entry = &cache->slots[(home + probe) & (CACHE_SIZE - 1)];
 
-        int space = search_space_pos(string); // search first space char
-        if (space != -1)
+        if (!entry->used)
+            break;
+        if (memcmp(entry->secret, serverWord, length) == 0 && memcmp(entry->guess, userWord, length) == 0)
         {
-            if (isspace(string[space]) && isspace(string[space + 1]))
-                return 2; // double space
+            cache->hits++;
+            return entry->pattern;
+        }
+    }
+
+    // miss: store in first free slot, evict home slot if none
+    feedback_entry *entry = &cache->slots[home];
+    for (unsigned int probe = 0; probe < CACHE_PROBES; probe++)
+        if (!cache->slots[(home + probe) & (CACHE_SIZE - 1)].used)
+        {
+            entry = &cache->slots[(home + probe) & (CACHE_SIZE - 1)];
+            break;
+        }
+
+    char *result = variant->check_word(serverWord, userWord);
+    memcpy(entry->secret, serverWord, length);
+    memcpy(entry->guess, userWord, length);
+    memcpy(entry->pattern, result, length + 1);
+    entry->used = 1;
+    free(result);
+
+    cache->misses++;
+    return entry->pattern;
+}
+
+/// @brief prints feedback cache statistics of the variant
+void print_stats(const game_variant *variant)
+{
+    const feedback_cache *cache = variant->cache;
+    unsigned long lookups = cache->hits + cache->misses;
+
+    fprintf(stderr, "Feedback cache %s/%d: %lu hits, %lu misses (%.1f%% hit rate)\n", variant->language, variant->length, cache->hits, cache->misses, lookups ? 100.0 * cache->hits / lookups : 0.0);
+    fflush(stderr);
+}
+
+/// @brief pick the word of the current time window, the same for every session
+/// @param window seconds each word lasts
+const char *generate_daily_word(const game_variant *variant, int window)
+{
+    int n = variant->wordCount;                 // get number of words in the dictionary
+    unsigned long slot = time(NULL) / window;   // number of the current window
+    slot = (slot ^ (slot >> 16)) * 0x45d9f3bUL; // scramble the schedule
+    slot ^= slot >> 16;
+    const char *wordToGuess = variant->words[slot % n]; // store the word of the window
+
+    return wordToGuess;
+}
 
-            int wordLength = 0;
-            *msg = malloc(sizeof(strlen(string) - 4));
-            for (int i = space + 1; *(string + i) != '\n' && i < MAX; i++) // retrieve world after "WORD "
-                if (isalpha(string[i]))                                    // if alphabetic character
+/// @brief generate random word for client to guess and return it
+/// @param seed session seed, the same seed picks the same word
+const char *generate_random_word(const game_variant *variant, unsigned int seed)
+{
+    int n = variant->wordCount;                            // get number of words in the dictionary
+    srand(seed);                                           // initialize random number generator
+    int randomIndex = rand() % n;                          // generate randon number between 0 and n-1
+    const char *wordToGuess = variant->words[randomIndex]; // store the random word
+
+    return wordToGuess;
+}
+
+/// @brief close journal file, rename it with current time as suffix and start a new one
+void roll_over_journal(journal *myJournal)
+{
+    char oldPath[MAX + 48] = "";
+    long now = (long)time(NULL);
+    struct stat existing;
+    sprintf(oldPath, "%s.%ld", myJournal->path, now);
+    for (int sequence = 1; stat(oldPath, &existing) == 0; sequence++) // keep archives rolled over in the same second
+        sprintf(oldPath, "%s.%ld.%d", myJournal->path, now, sequence);
+
+    close(myJournal->fd);
+    if (rename(myJournal->path, oldPath) != 0)
+        print_error("Journal roll over failed...");
+
+    myJournal->fd = open(myJournal->path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    myJournal->size = 0;
+    if (myJournal->fd < 0)
+        print_error("Journal reopen failed...");
+}
+
+/// @brief writer thread: appends queued records and syncs them in groups
+void *journal_writer(void *arg)
+{
+    journal *myJournal = arg;
+    static journal_record batch[JOURNAL_QUEUE]; // records taken from the queue, only used by this thread
+    int pending = 0;                            // records written but not synced yet
+    struct timespec syncDeadline = {0};         // latest sync time for pending records
+
+    while (1)
+    {
+        pthread_mutex_lock(&myJournal->lock);
+        while (myJournal->count == 0 && !myJournal->stop)
+            if (pending == 0)
+                pthread_cond_wait(&myJournal->notEmpty, &myJournal->lock);
+            else if (pthread_cond_timedwait(&myJournal->notEmpty, &myJournal->lock, &syncDeadline) == ETIMEDOUT)
+                break;
+
+        int n = myJournal->count; // take every queued record
+        for (int i = 0; i < n; i++)
+            batch[i] = myJournal->queue[(myJournal->head + i) % JOURNAL_QUEUE];
+        myJournal->head = (myJournal->head + n) % JOURNAL_QUEUE;
+        myJournal->count = 0;
+        int stop = myJournal->stop;
+        pthread_cond_broadcast(&myJournal->notFull);
+        pthread_mutex_unlock(&myJournal->lock);
+
+        if (n > 0 && myJournal->fd >= 0)
+        {
+            if (pending == 0) // first unsynced record, start the sync timer
+            {
+                clock_gettime(CLOCK_REALTIME, &syncDeadline);
+                syncDeadline.tv_sec += (syncDeadline.tv_nsec + JOURNAL_SYNC_MS * 1000000L) / 1000000000L;
+                syncDeadline.tv_nsec = (syncDeadline.tv_nsec + JOURNAL_SYNC_MS * 1000000L) % 1000000000L;
+            }
+
+            const char *data = (const char *)batch;
+            size_t left = n * sizeof(journal_record);
+            while (left > 0) // write whole batch
+            {
+                ssize_t written = write(myJournal->fd, data, left);
+                if (written < 0)
                 {
-                    *(*msg + (i - (space + 1))) = string[i]; // store it
-                    wordLength++;
+                    if (errno == EINTR)
+                        continue;
+                    print_error("Journal write failed...");
+                    break;
                 }
-                else
-                    return 3; // word is not alphabetic
+                data += written;
+                left -= written;
+                myJournal->size += written;
+            }
+            pending += n;
+        }
+
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        int expired = now.tv_sec > syncDeadline.tv_sec || (now.tv_sec == syncDeadline.tv_sec && now.tv_nsec >= syncDeadline.tv_nsec);
 
-            if (wordLength != WORD_LENGTH)
-                return 4; // wrong length
+        if (pending > 0 && (pending >= JOURNAL_SYNC_RECORDS || expired || stop)) // group commit
+        {
+            if (fdatasync(myJournal->fd) != 0)
+                print_error("Journal sync failed...");
+            pending = 0;
+
+            if (myJournal->size >= JOURNAL_MAX_SIZE)
+                roll_over_journal(myJournal);
         }
-        else
-            return 0; // malformed message
+
+        if (stop && n == 0 && pending == 0) // queue drained
+            return NULL;
     }
-    else if (cmdcmp(string, "QUIT\n", QUIT) == QUIT)
-        *cmd = QUIT;
-    else
-        return -1; // wrong command sent
-    return 1;
 }
 
-/// @brief compares word with reference and substitutes the letter with specific symbol
-/// @param serverWord reference word
-/// @param userWord compared word
-/// @return processed word
-char *check_word(const char *serverWord, char *userWord)
+/// @brief open journal file and start its writer thread
+/// @return resulting journal, NULL if it can't be opened
+journal *open_journal(const char *path)
+{
+    journal *myJournal = calloc(1, sizeof(journal));
+    strncpy(myJournal->path, path, MAX - 1);
+    myJournal->fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+
+    struct stat info;
+    if (myJournal->fd < 0 || fstat(myJournal->fd, &info) != 0)
+    {
+        fprintf(stderr, COLOR_RED "Cannot open journal %s.\n" COLOR_RESET, path);
+        free(myJournal);
+        return NULL;
+    }
+    myJournal->size = info.st_size;
+
+    pthread_mutex_init(&myJournal->lock, NULL);
+    pthread_cond_init(&myJournal->notEmpty, NULL);
+    pthread_cond_init(&myJournal->notFull, NULL);
+    pthread_create(&myJournal->writer, NULL, journal_writer, myJournal);
+
+    fprintf(stderr, COLOR_GREEN "Writing game results to %s..\n" COLOR_RESET, path);
+    fflush(stderr);
+    return myJournal;
+}
+
+/// @brief flush queued records, stop writer thread and close journal
+void close_journal(journal *myJournal)
 {
-    char *result = malloc(WORD_LENGTH);
+    if (myJournal == NULL)
+        return;
 
-    for (size_t i = 0; i < WORD_LENGTH; i++)
-        if (serverWord[i] == userWord[i]) // correct letter
-            result[i] = '*';
-        else if (strchr(serverWord, userWord[i]) != NULL) // correct letter wrong position
-            result[i] = '+';
-        else // incorrect letter
-            result[i] = '-';
+    pthread_mutex_lock(&myJournal->lock);
+    myJournal->stop = 1;
+    pthread_cond_signal(&myJournal->notEmpty);
+    pthread_mutex_unlock(&myJournal->lock);
+    pthread_join(myJournal->writer, NULL);
 
-    return result;
+    close(myJournal->fd);
+    pthread_mutex_destroy(&myJournal->lock);
+    pthread_cond_destroy(&myJournal->notEmpty);
+    pthread_cond_destroy(&myJournal->notFull);
+    free(myJournal);
 }
 
-/// @brief generate random word for client to guess and return it
-const char *generate_random_word()
+/// @brief queue game result for the writer thread
+/// @param outcome JOURNAL_PERFECT or JOURNAL_END
+void journal_game(journal *myJournal, sockaddr_t myClientName, const game_variant *variant, const char *wordToGuess, int attempts, int outcome)
 {
-    int n = sizeof(words) / sizeof(words[0]);     // get number of words in the array
-    srand(time(NULL));                            // initialize random number generator
-    int randomIndex = rand() % n;                 // generate randon number between 0 and n-1
-    const char *wordToGuess = words[randomIndex]; // store the random word
+    if (myJournal == NULL) // journal disabled
+        return;
 
-    return wordToGuess;
+    journal_record record = {0};
+    record.timestamp = time(NULL);
+    record.peer = (*myClientName).sin_addr.s_addr;
+    record.outcome = outcome;
+    record.attempts = attempts;
+    record.length = variant->length;
+    strncpy(record.language, variant->language, JOURNAL_LANGUAGE);
+    memcpy(record.secret, wordToGuess, variant->length);
+
+    pthread_mutex_lock(&myJournal->lock);
+    while (myJournal->count == JOURNAL_QUEUE) // writer thread far behind
+        pthread_cond_wait(&myJournal->notFull, &myJournal->lock);
+    myJournal->queue[(myJournal->head + myJournal->count) % JOURNAL_QUEUE] = record;
+    myJournal->count++;
+    pthread_cond_signal(&myJournal->notEmpty);
+    pthread_mutex_unlock(&myJournal->lock);
+}
+
+/// @brief sends the listening socket to the upgraded server connecting on the control socket
+/// @return 1 if the socket was handed off, 0 otherwise
+int hand_off_socket(int controlSocket, int listenSocket)
+{
+    int upgradeSocket = accept(controlSocket, NULL, NULL); // upgraded server waiting for the socket
+
+    if (upgradeSocket < 0)
+    {
+        print_error("Upgrade accept failed...");
+        return 0;
+    }
+
+    char payload = 'L'; // at least one byte must be sent along with the descriptor
+    struct iovec data = {&payload, sizeof(payload)};
+    union
+    {
+        struct cmsghdr header;
+        char space[CMSG_SPACE(sizeof(int))];
+    } control;
+    bzero(&control, sizeof(control));
+
+    struct msghdr message = {0};
+    message.msg_iov = &data;
+    message.msg_iovlen = 1;
+    message.msg_control = control.space;
+    message.msg_controllen = sizeof(control.space);
+
+    struct cmsghdr *header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS; // pass the descriptor itself
+    header->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(header), &listenSocket, sizeof(int));
+
+    int responseStatus = sendmsg(upgradeSocket, &message, 0);
+    close(upgradeSocket);
+
+    if (responseStatus < 0)
+    {
+        print_error("Listening socket hand off failed...");
+        return 0;
+    }
+
+    print_success("Listening socket handed off to upgraded server..");
+    return 1;
+}
+
+/// @brief waits for data on the socket, serving upgrade requests in the meantime
+/// @param controlSocket control socket, set to -1 once the listening socket has been handed off
+/// @param drainDeadline time limit for running game, set once the listening socket has been handed off
+/// @return 1 if socket is readable, 0 if drain deadline expired, listening socket handed off while idle or server stopping
+int wait_for_data(int mySocket, int listenSocket, int *controlSocket, time_t *drainDeadline)
+{
+    while (1)
+    {
+        if (stopRequested) // stop signals are only delivered inside ppoll(), none can be missed here
+            return 0;
+
+        struct pollfd fds[2] = {{mySocket, POLLIN, 0}, {*controlSocket, POLLIN, 0}};
+        struct timespec timeout = {0, 0};
+        struct timespec *waitTime = NULL; // wait forever unless draining
+
+        if (*drainDeadline != 0)
+        {
+            timeout.tv_sec = *drainDeadline - time(NULL);
+            if (timeout.tv_sec <= 0)
+                return 0;
+            waitTime = &timeout;
+        }
+
+        int ready = ppoll(fds, *controlSocket >= 0 ? 2 : 1, waitTime, &waitMask);
+
+        if (ready == 0) // deadline expired
+            return 0;
+        else if (ready < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            print_error("Poll failed...");
+            return 1; // let the caller handle the socket error
+        }
+
+        if (*controlSocket >= 0 && (fds[1].revents & POLLIN)) // upgraded server asks for listening socket
+        {
+            if (hand_off_socket(*controlSocket, listenSocket))
+            {
+                close(*controlSocket); // socket path now belongs to upgraded server
+                *controlSocket = -1;
+                *drainDeadline = time(NULL) + DRAIN_TIMEOUT;
+                if (mySocket == listenSocket) // no game running, nothing to drain
+                    return 0;
+            }
+            continue;
+        }
+
+        if (fds[0].revents)
+            return 1;
+    }
 }
 
 /// @brief chat between client and server
 /// @param maxAttempts number of max-attempts
-void chat(int maxAttempts, int mySocket)
+/// @param controlSocket socket on which upgraded servers ask for the listening socket, -1 if disabled
+/// @param dailyWindow seconds each daily word lasts, 0 for a random word per session
+/// @param variants hosted game variants, assigned to connections in turn
+/// @param myJournal game results journal, NULL if disabled
+/// @param myTrace session trace, NULL if disabled
+/// @param seed base seed, session n plays with seed + n
+void chat(int maxAttempts, int mySocket, int controlSocket, int dailyWindow, game_variant *variants, int variantCount, journal *myJournal, FILE *myTrace, unsigned int seed)
 {
     int actual_state = LISTENING;
+    time_t drainDeadline = 0; // set once the listening socket has been handed off
+    unsigned int games = 0;   // games played, picks the variant of the next one
 
     // infinite loop for chat
     while (actual_state == LISTENING)
     {
+        if (drainDeadline == 0)
+            wait_for_data(mySocket, mySocket, &controlSocket, &drainDeadline); // wait for connection or upgrade
+
+        if (drainDeadline != 0) // upgraded server is accepting, stop here
+        {
+            print_warning("No more games running, shutting down..");
+            actual_state = DRAINING;
+            continue;
+        }
+
+        if (stopRequested) // stop signal received
+        {
+            print_warning("Server stopped..");
+            actual_state = DRAINING;
+            continue;
+        }
+
         struct sockaddr_in clientName = {0};
+        unsigned int session = games++;            // session id
+        unsigned int sessionSeed = seed + session; // picks the word of the session
+        game_variant *variant = &variants[session % variantCount];
+        trace_message(myTrace, session, TRACE_OPEN, &sessionSeed, sizeof(sessionSeed));
 
-        int myConnectionSocket = accept_connection(mySocket, &clientName, maxAttempts); // accept incoming connection
-        const char *wordToGuess = generate_random_word();
+        int myConnectionSocket = accept_connection(mySocket, &clientName, maxAttempts, variant, myTrace, session); // accept incoming connection
+        const char *wordToGuess = dailyWindow ? generate_daily_word(variant, dailyWindow) : generate_random_word(variant, sessionSeed);
         int attempts = 1;
 
+        char received[MAX];        // bytes read from client, may hold several pipelined messages
+        size_t receivedLength = 0; // bytes in received
+
         int connectionStatus = CONNECTION_OPENED;
         while (connectionStatus == CONNECTION_OPENED)
         {
             char buffer[MAX];
-            bzero(buffer, MAX);                                                    // clear buffer
-            int responseStatus = read(myConnectionSocket, buffer, sizeof(buffer)); // read the message from client
+            bzero(buffer, MAX); // clear buffer
 
-            if (responseStatus > 0) // if you read a message
+            char *newline = memchr(received, '\n', receivedLength);
+            if (newline == NULL && receivedLength < MAX - 1) // no complete message yet
             {
+                if (!wait_for_data(myConnectionSocket, mySocket, &controlSocket, &drainDeadline)) // drain deadline expired or server stopping
+                {
+                    sprintf(buffer, ERROR_SERVER_SHUTDOWN);                                     // prepare error for client
+                    traced_write(myTrace, session, myConnectionSocket, buffer, sizeof(buffer)); // send error to client
+                    fprintf(stderr, "From server: ");                                           // print server message
+                    print_error(buffer);
+                    close_connection(myConnectionSocket, myTrace, session); // close connection
+                    connectionStatus = CONNECTION_CLOSED;
+                    continue;
+                }
+
+                int responseStatus = read(myConnectionSocket, received + receivedLength, MAX - 1 - receivedLength); // read the message from client
+
+                if (responseStatus <= 0) // client disconnected
+                {
+                    print_warning("Client disconnected..");
+                    close_connection(myConnectionSocket, myTrace, session); // close connection
+                    connectionStatus = CONNECTION_CLOSED;
+                }
+                else
+                {
+                    trace_message(myTrace, session, TRACE_IN, received + receivedLength, responseStatus);
+                    receivedLength += responseStatus;
+                }
+            }
+            else // handle first message, pipelined ones stay in received
+            {
+                size_t messageLength = newline != NULL ? (size_t)(newline - received) + 1 : receivedLength;
+                memcpy(buffer, received, messageLength);
+                memmove(received, received + messageLength, receivedLength - messageLength);
+                receivedLength -= messageLength;
+
                 fprintf(stderr, "From client: %s\n", buffer); // print client message
                 fflush(stderr);
 
                 // store message
                 commands cmd;               // command received
                 char *clientMessage = NULL; // message sent by client
-                int messageCorrect = retrieve_message(buffer, &cmd, &clientMessage);
+                int messageCorrect = variant->retrieve_message(buffer, &cmd, &clientMessage);
                 bzero(buffer, MAX); // clear buffer
 
                 if (messageCorrect == 1) // message correct
@@ -223,28 +740,33 @@ void chat(int maxAttempts, int mySocket)
                         connectionStatus = CONNECTION_CLOSED;
                     else // handle client WORD message
                     {
-                        char *guessWord = check_word(wordToGuess, clientMessage); // process word attempt by client
-                        if (strcmp(guessWord, "*****") == 0)                      // if string is correct
+                        const char *guessWord = cached_check_word(variant, wordToGuess, clientMessage); // process word attempt by client
+                        if (strspn(guessWord, "*") == (size_t)variant->length)                          // if string is correct
                         {
                             sprintf(buffer, PERFECT_MESSAGE); // prepare message for client
+                            journal_game(myJournal, &clientName, variant, wordToGuess, attempts, JOURNAL_PERFECT);
                             connectionStatus = CONNECTION_CLOSED;
                         }
                         else
                             sprintf(buffer, "OK %d %s\n", attempts, guessWord); // prepare message for client
 
                         free(clientMessage);
-                        free(guessWord);
 
-                        write(myConnectionSocket, buffer, sizeof(buffer)); // write word to server
-                        fprintf(stderr, "From server: %s", buffer);        // print server message
+                        if (traced_write(myTrace, session, myConnectionSocket, buffer, sizeof(buffer)) < 0 && (errno == EPIPE || errno == ECONNRESET)) // client left with pipelined messages
+                        {
+                            print_warning("Client disconnected..");
+                            connectionStatus = CONNECTION_LOST; // pending messages dropped
+                        }
+                        fprintf(stderr, "From server: %s", buffer); // print server message
                         fflush(stderr);
                         bzero(buffer, MAX); // clear buffer
 
-                        if (attempts == maxAttempts) // if last attempt
+                        if (connectionStatus == CONNECTION_OPENED && attempts == maxAttempts) // if last attempt missed, a win ends the game already
                         {
                             sprintf(buffer, "END %d %s\n", attempts, wordToGuess); // prepare message for client
-                            write(myConnectionSocket, buffer, sizeof(buffer));     // write word to server
-                            fprintf(stderr, "From server: %s", buffer);            // print server message
+                            journal_game(myJournal, &clientName, variant, wordToGuess, attempts, JOURNAL_END);
+                            traced_write(myTrace, session, myConnectionSocket, buffer, sizeof(buffer)); // write word to server
+                            fprintf(stderr, "From server: %s", buffer);                                 // print server message
                             fflush(stderr);
                             bzero(buffer, MAX); // clear buffer
                             connectionStatus = CONNECTION_CLOSED;
@@ -256,7 +778,7 @@ void chat(int maxAttempts, int mySocket)
                     if (connectionStatus == CONNECTION_CLOSED) // if word is correct or no more attempts
                     {
                         sprintf(buffer, "QUIT Succesfully disconnected.. The word was \'%s\' \n", wordToGuess); // prepare message for client
-                        write(myConnectionSocket, buffer, sizeof(buffer));                                      // write word to server
+                        traced_write(myTrace, session, myConnectionSocket, buffer, sizeof(buffer));             // write word to server
                         fprintf(stderr, "From server: %s", buffer);                                             // print server message
                         fflush(stderr);
                         bzero(buffer, MAX); // clear buffer
@@ -276,24 +798,26 @@ void chat(int maxAttempts, int mySocket)
                         sprintf(buffer, ERROR_CHAR_NOT_ALPHA); // prepare error for client
                         break;
                     case 4:                                  // wrong length
-                        sprintf(buffer, ERROR_WRONG_LENGTH); // prepare error for client
+                        sprintf(buffer, ERROR_WRONG_LENGTH, variant->length); // prepare error for client
                         break;
                     default:
                         sprintf(buffer, ERROR_MALFORMED_MESSAGE); // prepare error for client
                         break;
                     }
 
-                    write(myConnectionSocket, buffer, sizeof(buffer)); // send error to client
-                    fprintf(stderr, "From server: ");                  // print server message
+                    traced_write(myTrace, session, myConnectionSocket, buffer, sizeof(buffer)); // send error to client
+                    fprintf(stderr, "From server: ");                                           // print server message
                     print_error(buffer);
                     bzero(buffer, MAX); // clear buffer
                     connectionStatus = CONNECTION_CLOSED;
                 }
 
-                if (connectionStatus == CONNECTION_CLOSED)
-                    close(myConnectionSocket); // close connection
+                if (connectionStatus != CONNECTION_OPENED)
+                    close_connection(myConnectionSocket, myTrace, session); // close connection
             }
         }
+
+        print_stats(variant);
     }
 }
 
@@ -357,9 +881,214 @@ void server_listen(int mySocket)
         print_success("Server listening..");
 }
 
+/// @brief create unix socket on which upgraded servers ask for the listening socket
+/// @return resulting socket, -1 if upgrades are not available
+int create_control_socket(const char *path)
+{
+    struct sockaddr_un controlAddress = {0};
+    controlAddress.sun_family = AF_UNIX;
+    strncpy(controlAddress.sun_path, path, sizeof(controlAddress.sun_path) - 1);
+
+    int controlSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(path); // remove socket left by previous server
+
+    if (controlSocket < 0 || bind(controlSocket, (struct sockaddr *)&controlAddress, sizeof(controlAddress)) < 0 || listen(controlSocket, 1) != 0)
+    {
+        print_warning("Control socket creation failed, upgrades disabled..");
+        if (controlSocket >= 0)
+            close(controlSocket);
+        return -1;
+    }
+
+    fprintf(stderr, COLOR_GREEN "Waiting for upgrades on %s..\n" COLOR_RESET, path);
+    fflush(stderr);
+    return controlSocket;
+}
+
+/// @brief receive listening socket from running server
+/// @return received listening socket
+int receive_socket(const char *path)
+{
+    struct sockaddr_un controlAddress = {0};
+    controlAddress.sun_family = AF_UNIX;
+    strncpy(controlAddress.sun_path, path, sizeof(controlAddress.sun_path) - 1);
+
+    int controlSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (controlSocket < 0 || connect(controlSocket, (struct sockaddr *)&controlAddress, sizeof(controlAddress)) < 0)
+    {
+        print_error("Connection with the running server failed...");
+        exit(EXIT_FAILURE);
+    }
+
+    char payload;
+    struct iovec data = {&payload, sizeof(payload)};
+    union
+    {
+        struct cmsghdr header;
+        char space[CMSG_SPACE(sizeof(int))];
+    } control;
+    bzero(&control, sizeof(control));
+
+    struct msghdr message = {0};
+    message.msg_iov = &data;
+    message.msg_iovlen = 1;
+    message.msg_control = control.space;
+    message.msg_controllen = sizeof(control.space);
+
+    int responseStatus = recvmsg(controlSocket, &message, 0);
+    close(controlSocket);
+
+    struct cmsghdr *header = CMSG_FIRSTHDR(&message);
+    if (responseStatus <= 0 || header == NULL || header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS)
+    {
+        print_error("Listening socket not received...");
+        exit(EXIT_FAILURE);
+    }
+
+    int mySocket;
+    memcpy(&mySocket, CMSG_DATA(header), sizeof(int));
+    print_success("Listening socket received, server listening..");
+
+    return mySocket;
+}
+
+/// @brief create game variant with given language, length and dictionary
+/// @param path dictionary file with one word per line, NULL for built-in words
+/// @return 1 if created, 0 otherwise
+int init_variant(game_variant *variant, const char *language, int length, const char *path)
+{
+    if (length < MIN_WORD_LENGTH || length > MAX_WORD_LENGTH)
+    {
+        fprintf(stderr, COLOR_RED "Word length should be between %d and %d.\n" COLOR_RESET, MIN_WORD_LENGTH, MAX_WORD_LENGTH);
+        return 0;
+    }
+
+    bzero(variant, sizeof(*variant));
+    variant->length = length;
+    strncpy(variant->language, language, MAX_LANGUAGE - 1);
+    variant->retrieve_message = parsers[length - MIN_WORD_LENGTH]; // specialized for length at compile time
+    variant->check_word = scorers[length - MIN_WORD_LENGTH];
+
+    if (path == NULL) // built-in words
+    {
+        variant->words = words;
+        variant->wordCount = sizeof(words) / sizeof(words[0]);
+    }
+    else
+    {
+        FILE *dictionary = fopen(path, "r");
+        if (dictionary == NULL)
+        {
+            fprintf(stderr, COLOR_RED "Cannot open dictionary %s.\n" COLOR_RESET, path);
+            return 0;
+        }
+
+        char line[MAX];
+        int capacity = 0;
+        while (fgets(line, sizeof(line), dictionary) != NULL)
+        {
+            line[strcspn(line, "\r\n")] = '\0'; // strip newline
+
+            int valid = (int)strlen(line) == length;
+            for (int i = 0; valid && i < length; i++)
+                valid = isalpha(line[i]);
+            if (!valid) // skip words of other lengths
+                continue;
+
+            if (variant->wordCount == capacity) // grow dictionary
+            {
+                capacity = capacity ? capacity * 2 : 64;
+                variant->words = realloc(variant->words, capacity * sizeof(char *));
+            }
+            variant->words[variant->wordCount++] = strdup(line);
+        }
+        fclose(dictionary);
+
+        if (variant->wordCount == 0)
+        {
+            fprintf(stderr, COLOR_RED "No %d letters word in dictionary %s.\n" COLOR_RESET, length, path);
+            return 0;
+        }
+    }
+
+    variant->cache = calloc(1, sizeof(feedback_cache));
+    fprintf(stderr, COLOR_GREEN "Variant %s/%d ready with %d words..\n" COLOR_RESET, variant->language, variant->length, variant->wordCount);
+    fflush(stderr);
+
+    return 1;
+}
+
+/// @brief free dictionary and cache of the variant
+void free_variant(game_variant *variant)
+{
+    if (variant->words != words)
+    {
+        for (int i = 0; i < variant->wordCount; i++)
+            free((char *)variant->words[i]);
+        free(variant->words);
+    }
+    free(variant->cache);
+}
+
+/// @brief signal handler asking the server to stop
+void request_stop(int signalNumber)
+{
+    (void)signalNumber;
+    stopRequested = 1;
+}
+
 int main(int argc, char *argv[])
 {
     int attempts = 6;
+    int upgrade = 0;     // take the listening socket over from running server
+    int dailyWindow = 0; // seconds each daily word lasts, 0 if disabled
+    const char *journalPath = NULL;
+    const char *tracePath = NULL;
+    unsigned int seed = time(NULL); // base seed of the sessions
+    game_variant variants[MAX_VARIANTS];
+    int variantCount = 0;
+
+    while (argc > 1 && strncmp(argv[1], "--", 2) == 0) // drop options from arguments
+    {
+        if (strcmp(argv[1], UPGRADE_OPTION) == 0)
+            upgrade = 1;
+        else if (strcmp(argv[1], DAILY_OPTION) == 0)
+            dailyWindow = DAILY_WINDOW;
+        else if (strncmp(argv[1], DAILY_OPTION "=", strlen(DAILY_OPTION "=")) == 0 && atoi(argv[1] + strlen(DAILY_OPTION "=")) > 0)
+            dailyWindow = atoi(argv[1] + strlen(DAILY_OPTION "="));
+        else if (strncmp(argv[1], JOURNAL_OPTION "=", strlen(JOURNAL_OPTION "=")) == 0 && argv[1][strlen(JOURNAL_OPTION "=")] != '\0')
+            journalPath = argv[1] + strlen(JOURNAL_OPTION "=");
+        else if (strncmp(argv[1], TRACE_OPTION "=", strlen(TRACE_OPTION "=")) == 0 && argv[1][strlen(TRACE_OPTION "=")] != '\0')
+            tracePath = argv[1] + strlen(TRACE_OPTION "=");
+        else if (strncmp(argv[1], SEED_OPTION "=", strlen(SEED_OPTION "=")) == 0 && isdigit(argv[1][strlen(SEED_OPTION "=")]))
+            seed = strtoul(argv[1] + strlen(SEED_OPTION "="), NULL, 10);
+        else if (strncmp(argv[1], VARIANT_OPTION "=", strlen(VARIANT_OPTION "=")) == 0 && variantCount < MAX_VARIANTS)
+        {
+            char language[MAX_LANGUAGE] = "";
+            int length = 0, pathStart = 0;
+
+            if (sscanf(argv[1] + strlen(VARIANT_OPTION "="), "%7[^:]:%d:%n", language, &length, &pathStart) != 2 || pathStart == 0)
+            {
+                fprintf(stderr, "Malformed variant %s. Usage: " VARIANT_OPTION "=<language>:<length>:<dictionary-file>\n", argv[1]);
+                fflush(stderr);
+                exit(EXIT_FAILURE);
+            }
+            if (!init_variant(&variants[variantCount], language, length, argv[1] + strlen(VARIANT_OPTION "=") + pathStart))
+                exit(EXIT_FAILURE);
+            variantCount++;
+        }
+        else
+        {
+            fprintf(stderr, "Unknown option %s. Usage: %s " USAGE "\n", argv[1], argv[0]);
+            fflush(stderr);
+            exit(EXIT_FAILURE);
+        }
+
+        argv[1] = argv[0];
+        argv++;
+        argc--;
+    }
 
     // check arguments
     if (argc < 3)
@@ -371,7 +1100,7 @@ int main(int argc, char *argv[])
         }
         else
         {
-            fprintf(stderr, "Incorrect arguments. Usage: %s <port> [<max-attempts>]\n", argv[0]);
+            fprintf(stderr, "Incorrect arguments. Usage: %s " USAGE "\n", argv[0]);
             fflush(stderr);
             exit(EXIT_FAILURE);
         }
@@ -385,23 +1114,71 @@ int main(int argc, char *argv[])
         exit(EXIT_FAILURE);
     }
 
-    // create and verify streaming socket
-    int mySocket = create_socket();
+    if (variantCount == 0) // built-in words only
+        init_variant(&variants[variantCount++], DEFAULT_LANGUAGE, DEFAULT_LENGTH, NULL);
+
+    // Stop cleanly on SIGINT and SIGTERM, flushing journal and trace.
+    // Both stay blocked, journal writer thread included, and are only delivered while waiting in ppoll()
+    struct sigaction stopAction = {0};
+    stopAction.sa_handler = request_stop;
+    sigaction(SIGINT, &stopAction, NULL);
+    sigaction(SIGTERM, &stopAction, NULL);
+
+    // Clients leaving with pipelined messages make writes fail with EPIPE instead of killing the server
+    struct sigaction ignoreAction = {0};
+    ignoreAction.sa_handler = SIG_IGN;
+    sigaction(SIGPIPE, &ignoreAction, NULL);
+
+    sigset_t stopSignals;
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    sigprocmask(SIG_BLOCK, &stopSignals, &waitMask);
+
+    journal *myJournal = NULL;
+    if (journalPath != NULL && (myJournal = open_journal(journalPath)) == NULL)
+        exit(EXIT_FAILURE);
+
+    FILE *myTrace = NULL;
+    if (tracePath != NULL && (myTrace = open_trace(tracePath, seed)) == NULL)
+        exit(EXIT_FAILURE);
+
+    char controlPath[MAX] = "";
+    sprintf(controlPath, UPGRADE_SOCKET_PATH, atoi(argv[1]));
+
+    int mySocket;
+    sockaddr_t myServer = NULL;
+
+    if (upgrade) // listening socket comes from running server
+        mySocket = receive_socket(controlPath);
+    else
+    {
+        // create and verify streaming socket
+        mySocket = create_socket();
 
-    // server setup and assign
-    sockaddr_t myServer = init_server(AF_INET, INADDR_ANY, atoi(argv[1]));
+        // server setup and assign
+        myServer = init_server(AF_INET, INADDR_ANY, atoi(argv[1]));
 
-    // Binding socket to IP and verification
-    bind_socket(mySocket, (struct sockaddr *)myServer);
+        // Binding socket to IP and verification
+        bind_socket(mySocket, (struct sockaddr *)myServer);
+
+        // Now server is ready to listen and verification
+        server_listen(mySocket);
+    }
 
-    // Now server is ready to listen and verification
-    server_listen(mySocket);
+    // Wait for upgraded servers asking for the listening socket
+    int controlSocket = create_control_socket(controlPath);
 
     // Function for chatting between client and server
-    chat(attempts, mySocket);
+    chat(attempts, mySocket, controlSocket, dailyWindow, variants, variantCount, myJournal, myTrace, seed);
 
     // Close the socket
     close(mySocket);
     free(myServer);
+    for (int i = 0; i < variantCount; i++)
+        free_variant(&variants[i]);
+    close_journal(myJournal);
+    if (myTrace != NULL)
+        fclose(myTrace);
     return 0;
 }
\ No newline at end of file
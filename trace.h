@@ -0,0 +1,35 @@
+// On-disk format of the session traces, shared by server.c and replay.c.
+// A trace starts with a trace_header and goes on with trace_record entries,
+// each followed by the first length - zeros bytes of the message.
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+#define TRACE_MAGIC "WGTRACE1"
+
+#define TRACE_OPEN 1  // session opened, payload is the session seed
+#define TRACE_IN 2    // message read from client
+#define TRACE_OUT 3   // message written to client
+#define TRACE_CLOSE 4 // session closed, no payload
+
+typedef struct trace_header
+{
+    char magic[8]; // TRACE_MAGIC
+    uint64_t seed; // base seed, session n plays with seed + n
+} trace_header;
+
+typedef struct trace_record
+{
+    int64_t timestamp; // microseconds since epoch
+    uint32_t session;  // session id
+    uint16_t length;   // message bytes on the wire
+    uint8_t type;      // TRACE_OPEN, TRACE_IN, TRACE_OUT or TRACE_CLOSE
+    uint8_t zeros;     // trailing zero bytes of the message left out of the trace
+} trace_record;
+
+_Static_assert(sizeof(trace_header) == 16, "trace header must be 16 bytes");
+_Static_assert(sizeof(trace_record) == 16, "trace records must be 16 bytes");
+
+#endif
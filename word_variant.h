@@ -0,0 +1,84 @@
+// Parser and scorer specialized for a word length known at compile time.
+// Included by server.c once per supported length:
+//
+//     #define WORD_LENGTH 5
+//     #include "word_variant.h"
+//
+// defines retrieve_message_5() and check_word_5(), whose loops have a constant
+// trip count and are fully unrolled by the compiler. No include guard on purpose.
+
+#ifndef WORD_LENGTH
+#error "WORD_LENGTH must be defined before including word_variant.h"
+#endif
+
+#define VARIANT_CONCAT_(name, length) name##_##length
+#define VARIANT_CONCAT(name, length) VARIANT_CONCAT_(name, length)
+#define VARIANT(name) VARIANT_CONCAT(name, WORD_LENGTH)
+
+/// @brief retrieves command and message from the given string
+/// @return 1 if correct, -1 wrong command, 0 malformed, 2 double space, 3 not alphabetic, 4 wrong length
+int VARIANT(retrieve_message)(const char *string, commands *cmd, char **msg)
+{
+    if (cmdcmp(string, "WORD", WORD) == WORD)
+    {
+        *cmd = WORD;
+
+        int space = search_space_pos(string); // search first space char
+        if (space != -1)
+        {
+            if (isspace(string[space]) && isspace(string[space + 1]))
+                return 2; // double space
+
+            const char *word = string + space + 1; // word after "WORD "
+            for (int i = 0; i < WORD_LENGTH; i++)
+                if (word[i] == '\n')
+                    return 4; // word too short
+                else if (!isalpha(word[i]))
+                    return 3; // word is not alphabetic
+
+            if (word[WORD_LENGTH] != '\n') // word too long
+            {
+                for (int i = WORD_LENGTH; word[i] != '\n' && space + 1 + i < MAX; i++)
+                    if (!isalpha(word[i]))
+                        return 3; // word is not alphabetic
+                return 4;
+            }
+
+            *msg = malloc(WORD_LENGTH + 1);
+            memcpy(*msg, word, WORD_LENGTH); // store it
+            (*msg)[WORD_LENGTH] = '\0';
+        }
+        else
+            return 0; // malformed message
+    }
+    else if (cmdcmp(string, "QUIT\n", QUIT) == QUIT)
+        *cmd = QUIT;
+    else
+        return -1; // wrong command sent
+    return 1;
+}
+
+/// @brief compares word with reference and substitutes the letter with specific symbol
+/// @param serverWord reference word
+/// @param userWord compared word
+/// @return processed word
+char *VARIANT(check_word)(const char *serverWord, char *userWord)
+{
+    char *result = malloc(WORD_LENGTH + 1);
+    result[WORD_LENGTH] = '\0';
+
+    for (size_t i = 0; i < WORD_LENGTH; i++)
+        if (serverWord[i] == userWord[i]) // correct letter
+            result[i] = '*';
+        else if (memchr(serverWord, userWord[i], WORD_LENGTH) != NULL) // correct letter wrong position
+            result[i] = '+';
+        else // incorrect letter
+            result[i] = '-';
+
+    return result;
+}
+
+#undef VARIANT
+#undef VARIANT_CONCAT
+#undef VARIANT_CONCAT_
+#undef WORD_LENGTH